@@ -11,15 +11,531 @@
 #include <chrono>
 #include <functional>
 #include <iostream>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
 #include <stdio.h>
+#include <thread>
+#include <unordered_map>
 
+#include "flat_hash_map.h"
+#include "virtual_shared_cursor.h"
+#include "virtual_static_iter.h"
 #include "virtual_std_iter.h"
 
 typedef std::chrono::high_resolution_clock::time_point hres_t;
 typedef std::chrono::duration<size_t, std::ratio<1, 1000000> > duration_t; // micro-seconds.
 
+// The checks below instantiate every component so the build compiles all of it, and fail the run when a
+// component misbehaves.
+#define CHECK(cond)                                                                         \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(cond))                                                                        \
+        {                                                                                   \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond << std::endl; \
+            return false;                                                                   \
+        }                                                                                   \
+    } while (0)
+
+
+// Random inserts, overwrites and erases against std::unordered_map, then a full scan through
+// std_unordered_iter_impl.
+bool check_flat_hash_map()
+{
+    virtual_iter::flat_hash_map<int, int> flat;
+    std::unordered_map<int, int> reference;
+    std::mt19937 rng (1234);
+    std::uniform_int_distribution<int> key_dist (0, 2000);
+
+    for (int i = 0; i < 200000; ++i)
+    {
+        int key = key_dist (rng);
+        switch (rng () % 3)
+        {
+            case 0:
+                flat[key] = i;
+                reference[key] = i;
+                break;
+            case 1:
+                CHECK(flat.insert ({key, i}).second == reference.insert ({key, i}).second);
+                break;
+            default:
+                CHECK(flat.erase (key) == reference.erase (key));
+                break;
+        }
+    }
+
+    CHECK(flat.size () == reference.size ());
+    for (const auto& kv : reference)
+    {
+        auto found = flat.find (kv.first);
+        CHECK(found != flat.cend ());
+        CHECK(found->second == kv.second);
+    }
+    for (int key = 0; key <= 2000; ++key)
+        CHECK(flat.count (key) == reference.count (key));
+
+    // Overwriting an existing key at the load factor limit must not rehash.
+    virtual_iter::flat_hash_map<int, int> full;
+    for (int key = 0; key < 7; ++key)
+        full[key] = key;
+    size_t capacity = full.bucket_count ();
+    full[3] = 42;
+    CHECK(full.bucket_count () == capacity);
+
+    // Keys spaced by a power of two share all their low bits, so they only spread if the hash is scrambled.
+    virtual_iter::flat_hash_map<long, long> spaced;
+    for (long i = 0; i < 100000; ++i)
+        spaced[i * 4096] = i;
+    for (long i = 0; i < 100000; i += 2)
+        CHECK(spaced.erase (i * 4096) == 1);
+    CHECK(spaced.size () == 50000);
+    for (long i = 0; i < 100000; ++i)
+    {
+        auto found = spaced.find (i * 4096);
+        CHECK((found != spaced.end ()) == (i % 2 == 1));
+        CHECK(found == spaced.end () || found->second == i);
+    }
+
+    typedef std::pair<const int, int> pair_t;
+    virtual_iter::std_unordered_iter_impl<virtual_iter::flat_hash_map<int, int>, 48> impl (flat);
+    virtual_iter::fwd_iter<pair_t, 48> itr (impl, flat.cbegin ());
+    virtual_iter::fwd_iter<pair_t, 48> endItr (impl, flat.cend ());
+    CHECK(endItr - itr == (ssize_t) flat.size ());
+
+    std::vector<pair_t> buffer (100, pair_t (0, 0));
+    size_t copied = 0;
+    size_t count = 0;
+    while ((count = itr.copy (buffer.data (), buffer.size (), endItr)) != 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+            CHECK(reference.at (buffer[i].first) == buffer[i].second);
+        copied += count;
+    }
+    CHECK(copied == reference.size ());
+    CHECK(itr == endItr);
+    return true;
+}
+
+
+// The walk must stop at the end iterator even when the container changed after the iterators were made.
+bool check_unordered_iter_impl()
+{
+    typedef std::pair<const int, int> pair_t;
+    std::unordered_map<int, int> map;
+    for (int key = 0; key < 100; ++key)
+        map[key] = key;
+
+    virtual_iter::std_unordered_iter_impl<std::unordered_map<int, int>, 48> impl (map);
+    virtual_iter::fwd_iter<pair_t, 48> itr (impl, map.cbegin ());
+    virtual_iter::fwd_iter<pair_t, 48> endItr (impl, map.cend ());
+    map.erase (std::next (map.begin ())->first);
+
+    std::vector<pair_t> buffer (200, pair_t (0, 0));
+    CHECK(itr.copy (buffer.data (), buffer.size (), endItr) == 99);
+    CHECK(itr == endItr);
+
+    map.reserve (1000);
+    virtual_iter::fwd_iter<pair_t, 48> last (impl, map.cend ());
+    for (int key = 100; key < 150; ++key)
+        map[key] = key;
+
+    size_t visited = 0;
+    std::function<bool(const pair_t&)> count = [&visited](const pair_t&) {
+        ++visited;
+        return true;
+    };
+    virtual_iter::fwd_iter<pair_t, 48> start (impl, map.cbegin ());
+    start.visit (last, count);
+    CHECK(visited == map.size ());
+    return true;
+}
+
+
+// to_vector must size from exact hints, keep going past estimates and let checked impls reject bad ranges
+// before anything is allocated.
+bool check_to_vector()
+{
+    std::vector<int> values (5000);
+    std::iota (values.begin (), values.end (), 0);
+
+    auto impl = virtual_iter::std_rand_iter_impl<std::vector<int>::const_iterator, 48>();
+    virtual_iter::rand_iter<int, 48> first (impl, values.cbegin ());
+    virtual_iter::rand_iter<int, 48> last (impl, values.cend ());
+    CHECK(first.remaining_hint (last).is_exact ());
+    CHECK(first.remaining_hint (last).count == values.size ());
+    CHECK(virtual_iter::to_vector (first, last) == values);
+    CHECK(virtual_iter::to_vector (first + 10, last).size () == values.size () - 10);
+
+    typedef std::pair<const int, int> pair_t;
+    std::unordered_map<int, int> map;
+    map.reserve (1000);
+    for (int key = 0; key < 100; ++key)
+        map[key] = key;
+
+    virtual_iter::std_unordered_iter_impl<std::unordered_map<int, int>, 48> map_impl (map);
+    virtual_iter::fwd_iter<pair_t, 48> map_first (map_impl, map.cbegin ());
+    virtual_iter::fwd_iter<pair_t, 48> map_last (map_impl, map.cend ());
+    for (int key = 100; key < 150; ++key)
+        map[key] = key;
+
+    virtual_iter::fwd_iter<pair_t, 48> map_start (map_impl, map.cbegin ());
+    CHECK(map_start.remaining_hint (map_last).kind == virtual_iter::size_hint::ESTIMATE);
+    CHECK(virtual_iter::to_vector (map_start, map_last).size () == map.size ());
+
+    // A right estimate must be the final capacity: filling the last block may not grow past the reservation.
+    virtual_iter::fwd_iter<pair_t, 48> map_end (map_impl, map.cend ());
+    size_t estimate = map_start.remaining_hint (map_end).count;
+    CHECK(estimate == map.size ());
+    std::vector<pair_t> materialized = virtual_iter::to_vector (map_start, map_end, 64);
+    CHECK(materialized.size () == map.size ());
+    CHECK(materialized.capacity () == estimate);
+
+    std::vector<int> other (10);
+    virtual_iter::iter_generation values_gen;
+    virtual_iter::iter_generation other_gen;
+    virtual_iter::checked_std_rand_iter_impl<std::vector<int>::const_iterator, 48> values_impl (values_gen);
+    virtual_iter::checked_std_rand_iter_impl<std::vector<int>::const_iterator, 48> other_impl (other_gen);
+    virtual_iter::rand_iter<int, 48> checked_first (other_impl, other.cbegin ());
+    virtual_iter::rand_iter<int, 48> checked_last (values_impl, values.cend ());
+
+    bool rejected = false;
+    try
+    {
+        virtual_iter::to_vector (checked_first, checked_last);
+    }
+    catch (const virtual_iter::checked_iter_error&)
+    {
+        rejected = true;
+    }
+    CHECK(rejected);
+    return true;
+}
+
+
+// Every element must be handed out exactly once across concurrent workers.
+template <typename Cursor, typename Worker = typename Cursor::worker>
+bool check_cursor(Cursor& cursor, const std::vector<int>& values, size_t num_workers)
+{
+    std::atomic<size_t> count (0);
+    std::atomic<long> sum (0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_workers; ++i)
+    {
+        workers.emplace_back ([&cursor, &count, &sum]() {
+            Worker worker (cursor);
+            int buffer[512];
+            size_t copied = 0;
+            while ((copied = worker.next (buffer, 512)) != 0)
+            {
+                count += copied;
+                sum += std::accumulate (buffer, buffer + copied, 0L);
+            }
+        });
+    }
+    for (auto& worker : workers)
+        worker.join ();
+
+    CHECK(count == values.size ());
+    CHECK(sum == std::accumulate (values.begin (), values.end (), 0L));
+    return true;
+}
+
+
+bool check_shared_cursors()
+{
+    std::vector<int> values (100003);
+    std::iota (values.begin (), values.end (), 0);
+
+    auto rand_impl = virtual_iter::std_rand_iter_impl<std::vector<int>::const_iterator, 48>();
+    virtual_iter::rand_iter<int, 48> first (rand_impl, values.cbegin ());
+    virtual_iter::rand_iter<int, 48> last (rand_impl, values.cend ());
+    virtual_iter::shared_rand_cursor<int, 48> rand_cursor (first, last, 4, 64);
+    CHECK(rand_cursor.size () == values.size ());
+    if (!check_cursor (rand_cursor, values, 4))
+        return false;
+
+    auto fwd_impl = virtual_iter::std_fwd_iter_impl<std::vector<int>::const_iterator, 48>();
+    virtual_iter::fwd_iter<int, 48> fwd_first (fwd_impl, values.cbegin ());
+    virtual_iter::fwd_iter<int, 48> fwd_last (fwd_impl, values.cend ());
+    virtual_iter::shared_fwd_cursor<int, 48> fwd_cursor (fwd_first, fwd_last);
+    if (!check_cursor (fwd_cursor, values, 4))
+        return false;
+
+    // Batches larger than the workers' buffers are drained over several next calls, and two slots force
+    // the filler to wait for the ring to wrap.
+    virtual_iter::shared_fwd_cursor<int, 48> wide_cursor (fwd_first, fwd_last, 1000, 2);
+    if (!check_cursor (wide_cursor, values, 4))
+        return false;
+
+    // A cursor that is never drained must still stop its filler on destruction.
+    {
+        virtual_iter::shared_fwd_cursor<int, 48> abandoned (fwd_first, fwd_last, 16, 2);
+        virtual_iter::shared_fwd_cursor<int, 48>::worker worker (abandoned);
+        int buffer[8];
+        CHECK(worker.next (buffer, 8) == 8);
+        CHECK(buffer[0] == 0);
+    }
+    return true;
+}
+
+
+// An out_iter impl whose destination always fails.
+class failing_out_impl: public virtual_iter::_out_iter_impl_base<int>
+{
+public:
+    std::shared_ptr<virtual_iter::_out_iter_impl_base<int>> create_out_iter_impl()
+    {
+        return std::make_shared<failing_out_impl>();
+    }
+
+    void write_block(const int*, size_t) override
+    {
+        throw std::bad_alloc ();
+    }
+};
+
+
+bool check_out_iter()
+{
+    std::vector<int> values (1000);
+    std::iota (values.begin (), values.end (), 0);
+
+    std::vector<int> vector_sink;
+    {
+        virtual_iter::out_iter<int, 64> out {virtual_iter::std_back_insert_out_impl<std::vector<int>> (vector_sink)};
+        std::copy (values.begin (), values.end (), out);
+    }
+    CHECK(vector_sink == values);
+
+    std::deque<int> deque_sink;
+    {
+        virtual_iter::out_iter<int, 64> out {virtual_iter::std_back_insert_out_impl<std::deque<int>> (deque_sink)};
+        for (int value : values)
+            *out++ = value;
+        out.write (values.data (), 3);
+        out.write (values.data (), 100);
+    }
+    CHECK(deque_sink.size () == values.size () + 103);
+    CHECK(deque_sink[values.size () + 102] == 99);
+
+    std::vector<int> pointer_sink (values.size ());
+    {
+        virtual_iter::out_iter<int, 32> out {virtual_iter::std_pointer_out_impl<int> (pointer_sink.data ())};
+        out = std::copy (values.begin (), values.end (), out);
+    }
+    CHECK(pointer_sink == values);
+
+    std::vector<int> inserter_sink;
+    {
+        typedef std::back_insert_iterator<std::vector<int>> inserter_t;
+        virtual_iter::out_iter<int, 64> out {virtual_iter::std_out_iter_impl<int, inserter_t> (std::back_inserter (inserter_sink))};
+        std::copy (values.begin (), values.end (), out);
+    }
+    CHECK(inserter_sink == values);
+
+    // Explicit flushes report write errors; the destructor swallows them.
+    bool reported = false;
+    {
+        virtual_iter::out_iter<int, 64> out {failing_out_impl ()};
+        *out++ = 1;
+        try
+        {
+            out.flush ();
+        }
+        catch (const std::bad_alloc&)
+        {
+            reported = true;
+        }
+        *out++ = 2;
+    }
+    CHECK(reported);
+    return true;
+}
+
+
+bool check_reverse()
+{
+    std::vector<int> values (1000);
+    std::iota (values.begin (), values.end (), 0);
+
+    auto impl = virtual_iter::std_rand_iter_impl<std::vector<int>::const_iterator, 48>();
+    virtual_iter::rand_iter<int, 48> first (impl, values.cbegin ());
+    virtual_iter::rand_iter<int, 48> last (impl, values.cend ());
+
+    int buffer[10];
+    virtual_iter::rand_iter<int, 48> pos (last);
+    CHECK(pos.copy_backward (buffer, 10, first) == 10);
+    CHECK(buffer[0] == 999 && buffer[9] == 990);
+    CHECK(*pos == 990);
+
+    virtual_iter::reverse_view<int, 48> view (first, last);
+    CHECK(view.size () == (ssize_t) values.size ());
+    int expected = 999;
+    for (int value : view)
+        CHECK(value == expected--);
+    CHECK(expected == -1);
+    CHECK(std::accumulate (view.begin (), view.end (), 0L) == 499500);
+
+    // A non contiguous source and early termination of visit_reverse.
+    std::deque<std::string> words {"a", "b", "c"};
+    auto deque_impl = virtual_iter::std_rand_iter_impl<std::deque<std::string>::const_iterator, 48>();
+    virtual_iter::rand_iter<std::string, 48> words_first (deque_impl, words.cbegin ());
+    virtual_iter::rand_iter<std::string, 48> words_last (deque_impl, words.cend ());
+
+    std::string joined;
+    std::function<bool(const std::string&)> join = [&joined](const std::string& word) {
+        joined += word;
+        return word != "b";
+    };
+    virtual_iter::rand_iter<std::string, 48> words_pos (words_last);
+    words_pos.visit_reverse (words_first, join);
+    CHECK(joined == "cb");
+    CHECK(words_pos - words_first == 2);
+
+    virtual_iter::reverse_view<std::string, 48, 2> words_view (words_first, words_last);
+    std::string reversed[5];
+    CHECK(words_view.copy (reversed, 5) == 3);
+    CHECK(reversed[2] == "a");
+    return true;
+}
+
+
+// Runs f and reports whether it threw checked_iter_error.
+template <typename Func>
+bool rejects(Func f)
+{
+    try
+    {
+        f ();
+    }
+    catch (const virtual_iter::checked_iter_error&)
+    {
+        return true;
+    }
+    return false;
+}
+
+
+bool check_checked_impls()
+{
+    typedef virtual_iter::rand_iter<int, 48> rand_iter_t;
+    std::vector<int> values (100);
+    std::vector<int> other (100);
+    std::iota (values.begin (), values.end (), 0);
+
+    virtual_iter::iter_generation values_gen;
+    virtual_iter::iter_generation other_gen;
+    virtual_iter::checked_std_rand_iter_impl<std::vector<int>::const_iterator, 48> values_impl (values_gen);
+    virtual_iter::checked_std_rand_iter_impl<std::vector<int>::const_iterator, 48> other_impl (other_gen);
+    rand_iter_t first (values_impl, values.cbegin ());
+    rand_iter_t last (values_impl, values.cend ());
+    rand_iter_t other_first (other_impl, other.cbegin ());
+
+    int buffer[200];
+    rand_iter_t pos (first);
+    CHECK(pos.copy (buffer, 200, last) == 100);
+    CHECK(buffer[99] == 99);
+    rand_iter_t back (last);
+    CHECK(back.copy_backward (buffer, 3, first) == 3);
+    CHECK(buffer[0] == 99);
+
+    rand_iter_t middle = first + 50;
+    CHECK(*middle == 50);
+
+    CHECK(rejects ([&]() { rand_iter_t itr (other_first); itr.copy (buffer, 10, last); }));
+    CHECK(rejects ([&]() { rand_iter_t itr (last); itr.copy (buffer, 10, first); }));
+    CHECK(rejects ([&]() { rand_iter_t itr (first); itr.copy_backward (buffer, 10, last); }));
+
+    // Stale iterators are rejected, including ones derived from them with +, while fresh ones work.
+    values_gen.invalidate ();
+    CHECK(rejects ([&]() { rand_iter_t itr (first); itr.copy (buffer, 10, last); }));
+    rand_iter_t fresh_first (values_impl, values.cbegin ());
+    rand_iter_t fresh_last (values_impl, values.cend ());
+    CHECK(rejects ([&]() { rand_iter_t itr (middle + 1); itr.copy (buffer, 10, fresh_last); }));
+    CHECK(fresh_first.copy (buffer, 200, fresh_last) == 100);
+
+    std::deque<int> numbers (5, 2);
+    virtual_iter::checked_std_fwd_iter_impl<std::deque<int>::const_iterator, 48> deque_impl (other_gen);
+    virtual_iter::fwd_iter<int, 48> deque_first (deque_impl, numbers.cbegin ());
+    virtual_iter::fwd_iter<int, 48> deque_last (deque_impl, numbers.cend ());
+
+    int sum = 0;
+    std::function<bool(const int&)> add = [&sum](const int& value) {
+        sum += value;
+        return true;
+    };
+    deque_first.visit (deque_last, add);
+    CHECK(sum == 10);
+
+    other_gen.invalidate ();
+    CHECK(rejects ([&]() { deque_last.visit (deque_first, add); }));
+    return true;
+}
+
+
+bool check_static_iters()
+{
+    typedef virtual_iter_detail::type_list<std::vector<int>::const_iterator, std::deque<int>::const_iterator> rand_list_t;
+    typedef virtual_iter_detail::type_list<std::vector<int>::const_iterator, std::list<int>::const_iterator> fwd_list_t;
+    typedef virtual_iter::static_rand_iter<int, 48, rand_list_t> static_rand_t;
+    typedef virtual_iter::static_fwd_iter<int, 48, fwd_list_t> static_fwd_t;
+
+    std::vector<int> values (100);
+    std::iota (values.begin (), values.end (), 0);
+    std::deque<int> numbers (values.begin (), values.end ());
+    std::list<int> linked (values.begin (), values.end ());
+
+    static_rand_t first (numbers.cbegin ());
+    static_rand_t last (numbers.cend ());
+    CHECK(last - first == 100);
+    CHECK(*(first + 5) == 5);
+    CHECK(*(last - 1) == 99);
+    CHECK(!(first == static_rand_t (values.cbegin ())));
+
+    static_rand_t pos (last);
+    --pos;
+    pos -= 9;
+    CHECK(*pos == 90);
+
+    int buffer[200];
+    CHECK(pos.copy_backward (buffer, 200, first) == 90);
+    CHECK(buffer[0] == 89);
+    CHECK(virtual_iter::to_vector (first, last) == values);
+
+    static_fwd_t list_first (linked.cbegin ());
+    static_fwd_t list_last (linked.cend ());
+    CHECK(list_first.remaining_hint (list_last).kind == virtual_iter::size_hint::UNKNOWN);
+    CHECK(virtual_iter::to_vector (list_first, list_last, 16) == values);
+
+    static_fwd_t list_pos (list_first);
+    CHECK(list_pos.copy (buffer, 7, list_last) == 7);
+    CHECK(*list_pos == 7);
+    return true;
+}
+
+
+bool run_checks()
+{
+    return check_reverse () &&
+           check_flat_hash_map () &&
+           check_unordered_iter_impl () &&
+           check_checked_impls () &&
+           check_static_iters () &&
+           check_to_vector () &&
+           check_shared_cursors () &&
+           check_out_iter ();
+}
+
+
 int main()
 {
+    if (!run_checks ())
+        return 1;
+
     auto vec = std::vector<int> (10000000, 1);
 
     size_t result = 0;
@@ -38,6 +554,8 @@ int main()
     std::cout << "result: " << result << std::endl;
     std::cout << "vector iterator timing: " << timespan.count () << std::endl;
 
+    using virtual_iter::fwd_iter;
+
     auto impl = virtual_iter::std_fwd_iter_impl<std::vector<int>::const_iterator, 48>();
 
     virtual_iter::fwd_iter<int, 48> itr (impl, vec.begin ());
@@ -83,6 +601,100 @@ int main()
     std::cout << "snapshot::iter timing: " << timespan.count () << std::endl;
     std::cout << "result: " << result << std::endl;
 
+    // Per element iteration through the virtual and the static dispatch flavors.
+    result = 0;
+    fwd_iter<int, 48> loopItr (impl, vec.begin ());
+    hres_t loopStart = std::chrono::high_resolution_clock::now ();
+
+    for (; loopItr != endItr; ++loopItr)
+    {
+        result += *loopItr;
+    }
+
+    hres_t loopEnd = std::chrono::high_resolution_clock::now ();
+    timespan = std::chrono::duration_cast<duration_t> (loopEnd - loopStart);
+    std::cout << "fwd_iter loop timing: " << timespan.count () << std::endl;
+    std::cout << "result: " << result << std::endl;
+
+    typedef virtual_iter_detail::type_list<std::vector<int>::const_iterator,
+                                           std::deque<int>::const_iterator> iter_list_t;
+    typedef virtual_iter::static_fwd_iter<int, 48, iter_list_t> static_iter_t;
+
+    static_iter_t staticItr (vec.cbegin ());
+    static_iter_t staticEndItr (vec.cend ());
+
+    result = 0;
+    hres_t staticStart = std::chrono::high_resolution_clock::now ();
+
+    for (; staticItr != staticEndItr; ++staticItr)
+    {
+        result += *staticItr;
+    }
+
+    hres_t staticEnd = std::chrono::high_resolution_clock::now ();
+    timespan = std::chrono::duration_cast<duration_t> (staticEnd - staticStart);
+    std::cout << "static_fwd_iter loop timing: " << timespan.count () << std::endl;
+    std::cout << "result: " << result << std::endl;
+
+    // Multi-consumer handout of one range: a mutex around a shared fwd_iter (the baseline the cursors
+    // replace) against shared_fwd_cursor and shared_rand_cursor.
+    const size_t num_workers = std::max (4u, std::thread::hardware_concurrency ());
+    const size_t batch = 256;
+
+    typedef std::function<size_t(int*, size_t)> next_fn_t;
+    auto run_workers = [num_workers](const char* label, const std::function<next_fn_t()>& make_next) {
+        std::atomic<size_t> total (0);
+        std::vector<std::thread> workers;
+        hres_t start = std::chrono::high_resolution_clock::now ();
+        for (size_t i = 0; i < num_workers; ++i)
+        {
+            workers.emplace_back ([&make_next, &total]() {
+                next_fn_t next = make_next ();
+                int buffer[batch];
+                size_t local = 0;
+                size_t copied = 0;
+                while ((copied = next (buffer, batch)) != 0)
+                    local = std::accumulate (buffer, buffer + copied, local);
+                total += local;
+            });
+        }
+        for (auto& worker : workers)
+            worker.join ();
+
+        hres_t end = std::chrono::high_resolution_clock::now ();
+        duration_t span = std::chrono::duration_cast<duration_t> (end - start);
+        std::cout << label << " (" << num_workers << " threads) timing: " << span.count () << std::endl;
+        std::cout << "result: " << total << std::endl;
+    };
+
+    std::mutex mutex;
+    fwd_iter<int, 48> mutexItr (impl, vec.begin ());
+    run_workers ("mutex fwd_iter", [&mutex, &mutexItr, &endItr]() -> next_fn_t {
+        return [&mutex, &mutexItr, &endItr](int* buffer, size_t max_items) {
+            std::lock_guard<std::mutex> lock (mutex);
+            return mutexItr.copy (buffer, max_items, endItr);
+        };
+    });
+
+    virtual_iter::shared_fwd_cursor<int, 48> fwdCursor (fwd_iter<int, 48> (impl, vec.begin ()), endItr, batch);
+    run_workers ("shared_fwd_cursor", [&fwdCursor]() -> next_fn_t {
+        auto worker = std::make_shared<virtual_iter::shared_fwd_cursor<int, 48>::worker> (fwdCursor);
+        return [worker](int* buffer, size_t max_items) {
+            return worker->next (buffer, max_items);
+        };
+    });
+
+    auto randImpl = virtual_iter::std_rand_iter_impl<std::vector<int>::const_iterator, 48>();
+    virtual_iter::rand_iter<int, 48> randBegin (randImpl, vec.cbegin ());
+    virtual_iter::rand_iter<int, 48> randEnd (randImpl, vec.cend ());
+    virtual_iter::shared_rand_cursor<int, 48> randCursor (randBegin, randEnd, num_workers, batch);
+    run_workers ("shared_rand_cursor", [&randCursor]() -> next_fn_t {
+        auto worker = std::make_shared<virtual_iter::shared_rand_cursor<int, 48>::worker> (randCursor);
+        return [worker](int* buffer, size_t max_items) {
+            return worker->next (buffer, max_items);
+        };
+    });
+
     return 0;
 }
 
@@ -0,0 +1,390 @@
+/***********************************************************************************************************************
+ * virtual_iter:
+ * Iterator types for opaque sequence collections.
+ * Copyright 2020 Kuberan Naganathan
+ * Released under the terms of the MIT license:
+ * https://opensource.org/licenses/MIT
+ **********************************************************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <sys/types.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace virtual_iter
+{
+    // Open addressing hash map with linear probing.  Elements live in one flat slot array next to an array of
+    // control bytes, so a full table scan is a linear walk over two arrays instead of a node chain.  The
+    // iterators expose scan_n which std_unordered_iter_impl uses to copy and visit whole blocks.
+    //
+    // Erase uses backward shift deletion so there are no tombstones.  Iterator invalidation is stricter than
+    // std::unordered_map: inserts that grow the table invalidate all iterators, and erase may shift other
+    // elements into new slots, so it invalidates all iterators too and must not run during a scan.
+    template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class flat_hash_map
+    {
+    public:
+        typedef Key key_type;
+        typedef Value mapped_type;
+        typedef std::pair<const Key, Value> value_type;
+        typedef size_t size_type;
+        typedef ssize_t difference_type;
+        typedef Hash hasher;
+        typedef KeyEqual key_equal;
+
+    private:
+        struct slot
+        {
+            value_type& value()
+            {return *std::launder (reinterpret_cast<value_type*>(m_storage));}
+
+            alignas(value_type) unsigned char m_storage[sizeof(value_type)];
+        };
+
+        static constexpr uint8_t EMPTY = 0;
+        static constexpr uint8_t FULL = 1;
+
+    public:
+        template <bool IsConst>
+        class iterator_impl
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef typename flat_hash_map::value_type value_type;
+            typedef ssize_t difference_type;
+            typedef std::conditional_t<IsConst, const value_type*, value_type*> pointer;
+            typedef std::conditional_t<IsConst, const value_type&, value_type&> reference;
+
+            // Number of slots ahead of the scan position that scan_n prefetches.
+            static constexpr size_t prefetch_distance = 16;
+
+            iterator_impl():
+                m_ctrl(nullptr),
+                m_slots(nullptr),
+                m_index(0),
+                m_capacity(0)
+            {
+            }
+
+            iterator_impl(const uint8_t* ctrl, slot* slots, size_t index, size_t capacity):
+                m_ctrl(ctrl),
+                m_slots(slots),
+                m_index(index),
+                m_capacity(capacity)
+            {
+                skip_empty ();
+            }
+
+            template <bool RhsConst, std::enable_if_t<IsConst && !RhsConst, int> = 0>
+            iterator_impl(const iterator_impl<RhsConst>& rhs):
+                m_ctrl(rhs.m_ctrl),
+                m_slots(rhs.m_slots),
+                m_index(rhs.m_index),
+                m_capacity(rhs.m_capacity)
+            {
+            }
+
+            reference operator*() const
+            {return m_slots[m_index].value ();}
+
+            pointer operator->() const
+            {return &m_slots[m_index].value ();}
+
+            iterator_impl& operator++()
+            {
+                ++m_index;
+                skip_empty ();
+                return *this;
+            }
+
+            iterator_impl operator++(int)
+            {
+                iterator_impl result (*this);
+                ++(*this);
+                return result;
+            }
+
+            // Templated so iterator and const_iterator compare against each other, as with std containers.
+            template <bool RhsConst>
+            bool operator==(const iterator_impl<RhsConst>& rhs) const
+            {return m_index == rhs.m_index && m_slots == rhs.m_slots;}
+
+            template <bool RhsConst>
+            bool operator!=(const iterator_impl<RhsConst>& rhs) const
+            {return !(*this == rhs);}
+
+            // Hands up to n elements before end to f scanning the control bytes linearly and prefetching slots
+            // ahead of the scan.  Stops early, without moving past the current element, when f returns false.
+            // Returns the number of elements consumed.
+            template <typename Func>
+            size_t scan_n(size_t n, const iterator_impl& end, Func&& f)
+            {
+                size_t limit = std::min (end.m_index, m_capacity);
+                size_t consumed = 0;
+                while (consumed < n && m_index < limit)
+                {
+                    if (m_ctrl[m_index] == FULL)
+                    {
+                        if (m_index + prefetch_distance < m_capacity)
+                            __builtin_prefetch (&m_slots[m_index + prefetch_distance]);
+
+                        if (!f (static_cast<const value_type&>(m_slots[m_index].value ())))
+                            return consumed;
+
+                        ++consumed;
+                    }
+                    ++m_index;
+                }
+                skip_empty ();
+                return consumed;
+            }
+
+        private:
+            template <bool>
+            friend class iterator_impl;
+
+            void skip_empty()
+            {
+                while (m_index < m_capacity && m_ctrl[m_index] == EMPTY)
+                    ++m_index;
+            }
+
+            const uint8_t* m_ctrl;
+            slot* m_slots;
+            size_t m_index;
+            size_t m_capacity;
+        };
+
+        typedef iterator_impl<false> iterator;
+        typedef iterator_impl<true> const_iterator;
+
+        flat_hash_map():
+            m_size(0),
+            m_capacity(0)
+        {
+        }
+
+        flat_hash_map(const flat_hash_map& rhs):
+            flat_hash_map()
+        {
+            reserve (rhs.size ());
+            for (const value_type& value : rhs)
+                insert (value);
+        }
+
+        flat_hash_map(flat_hash_map&& rhs) noexcept:
+            flat_hash_map()
+        {
+            swap (rhs);
+        }
+
+        flat_hash_map& operator=(flat_hash_map rhs)
+        {
+            swap (rhs);
+            return *this;
+        }
+
+        ~flat_hash_map()
+        {
+            clear ();
+        }
+
+        void swap(flat_hash_map& rhs) noexcept
+        {
+            std::swap (m_ctrl, rhs.m_ctrl);
+            std::swap (m_slots, rhs.m_slots);
+            std::swap (m_size, rhs.m_size);
+            std::swap (m_capacity, rhs.m_capacity);
+            std::swap (m_hash, rhs.m_hash);
+            std::swap (m_equal, rhs.m_equal);
+        }
+
+        size_t size() const
+        {return m_size;}
+
+        bool empty() const
+        {return m_size == 0;}
+
+        size_t bucket_count() const
+        {return m_capacity;}
+
+        iterator begin()
+        {return iterator (m_ctrl.get (), m_slots.get (), 0, m_capacity);}
+
+        iterator end()
+        {return iterator (m_ctrl.get (), m_slots.get (), m_capacity, m_capacity);}
+
+        const_iterator begin() const
+        {return const_iterator (m_ctrl.get (), m_slots.get (), 0, m_capacity);}
+
+        const_iterator end() const
+        {return const_iterator (m_ctrl.get (), m_slots.get (), m_capacity, m_capacity);}
+
+        const_iterator cbegin() const
+        {return begin ();}
+
+        const_iterator cend() const
+        {return end ();}
+
+        template <typename K, typename ... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&& ... args)
+        {
+            // Look the key up before growing so that assigning to an existing key never rehashes.
+            size_t index = m_capacity ? probe (key) : 0;
+            if (m_capacity && m_ctrl[index] == FULL)
+                return {iterator (m_ctrl.get (), m_slots.get (), index, m_capacity), false};
+
+            if ((m_size + 1) * 8 > m_capacity * 7)
+            {
+                reserve (m_size + 1);
+                index = probe (key);
+            }
+
+            new (m_slots[index].m_storage) value_type (std::piecewise_construct,
+                                                       std::forward_as_tuple (std::forward<K> (key)),
+                                                       std::forward_as_tuple (std::forward<Args> (args)...));
+            m_ctrl[index] = FULL;
+            ++m_size;
+            return {iterator (m_ctrl.get (), m_slots.get (), index, m_capacity), true};
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value)
+        {return try_emplace (value.first, value.second);}
+
+        Value& operator[](const Key& key)
+        {return try_emplace (key).first->second;}
+
+        iterator find(const Key& key)
+        {
+            size_t index = m_capacity ? probe (key) : 0;
+            return m_capacity && m_ctrl[index] == FULL ? iterator (m_ctrl.get (), m_slots.get (), index, m_capacity) : end ();
+        }
+
+        const_iterator find(const Key& key) const
+        {return const_cast<flat_hash_map*>(this)->find (key);}
+
+        size_t count(const Key& key) const
+        {return find (key) != end () ? 1 : 0;}
+
+        size_t erase(const Key& key)
+        {
+            if (m_capacity == 0)
+                return 0;
+
+            size_t hole = probe (key);
+            if (m_ctrl[hole] == EMPTY)
+                return 0;
+
+            destroy (hole);
+            --m_size;
+
+            // Backward shift: pull later members of the probe run into the hole unless that would move them
+            // in front of their home slot.
+            size_t mask = m_capacity - 1;
+            for (size_t next = (hole + 1) & mask; m_ctrl[next] == FULL; next = (next + 1) & mask)
+            {
+                size_t next_home = home (m_slots[next].value ().first);
+                bool movable = hole <= next ? (next_home <= hole || next_home > next)
+                                            : (next_home <= hole && next_home > next);
+                if (movable)
+                {
+                    new (m_slots[hole].m_storage) value_type (std::move (m_slots[next].value ()));
+                    m_ctrl[hole] = FULL;
+                    destroy (next);
+                    hole = next;
+                }
+            }
+            return 1;
+        }
+
+        void clear()
+        {
+            for (size_t i = 0; i < m_capacity && m_size; ++i)
+            {
+                if (m_ctrl[i] == FULL)
+                {
+                    destroy (i);
+                    --m_size;
+                }
+            }
+        }
+
+        // Grows the table so that count elements fit under the maximum load factor of 7/8.
+        void reserve(size_t count)
+        {
+            if (count * 8 <= m_capacity * 7)
+                return;
+
+            size_t capacity = m_capacity ? m_capacity : 8;
+            while (count * 8 > capacity * 7)
+                capacity *= 2;
+
+            rehash (capacity);
+        }
+
+    private:
+        // Slot a key hashes to.  std::hash is the identity for integers, so masking it directly piles keys
+        // spaced by powers of two (aligned ids, pointers) onto a few slots.  A Fibonacci multiply spreads
+        // every input bit into the high bits, and the top log2(capacity) of those pick the slot.
+        size_t home(const Key& key) const
+        {
+            return (size_t) (((uint64_t) m_hash (key) * 0x9E3779B97F4A7C15ull) >> (64 - __builtin_ctzll (m_capacity)));
+        }
+
+        // Index of the slot holding key or, failing that, of the empty slot that ends its probe run.
+        size_t probe(const Key& key) const
+        {
+            size_t mask = m_capacity - 1;
+            size_t index = home (key);
+            while (m_ctrl[index] == FULL && !m_equal (m_slots[index].value ().first, key))
+                index = (index + 1) & mask;
+            return index;
+        }
+
+        void destroy(size_t index)
+        {
+            m_slots[index].value ().~value_type();
+            m_ctrl[index] = EMPTY;
+        }
+
+        void rehash(size_t capacity)
+        {
+            std::unique_ptr<uint8_t[]> old_ctrl (new uint8_t[capacity]());
+            std::unique_ptr<slot[]> old_slots (new slot[capacity]);
+            size_t old_capacity = m_capacity;
+
+            std::swap (m_ctrl, old_ctrl);
+            std::swap (m_slots, old_slots);
+            m_capacity = capacity;
+
+            for (size_t i = 0; i < old_capacity; ++i)
+            {
+                if (old_ctrl[i] == FULL)
+                {
+                    // Keys are unique, so the new slot is the first empty one from home.
+                    value_type& value = old_slots[i].value ();
+                    size_t index = home (value.first);
+                    while (m_ctrl[index] == FULL)
+                        index = (index + 1) & (capacity - 1);
+                    new (m_slots[index].m_storage) value_type (std::move (value));
+                    m_ctrl[index] = FULL;
+                    value.~value_type();
+                }
+            }
+        }
+
+        std::unique_ptr<uint8_t[]> m_ctrl;
+        std::unique_ptr<slot[]> m_slots;
+        size_t m_size;
+        size_t m_capacity;
+        Hash m_hash;
+        KeyEqual m_equal;
+    };
+}
@@ -7,8 +7,10 @@
  **********************************************************************************************************************/
 #pragma once
 
+#include <algorithm>
 #include <deque>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <set>
 #include <sys/types.h>
@@ -20,6 +22,39 @@ namespace virtual_iter
     template <typename T, size_t MemSize>
     class fwd_iter;
 
+
+    // How many elements remain between an iterator and the end of its range, as far as the impl can tell
+    // in O(1).  count is exact for EXACT, a minimum for LOWER_BOUND, a best guess for ESTIMATE and 0 for
+    // UNKNOWN.  Only EXACT may be used to size a result; the others are for reserving.
+    struct size_hint
+    {
+        enum kind_t
+        {
+            UNKNOWN,
+            ESTIMATE,
+            LOWER_BOUND,
+            EXACT
+        };
+
+        static size_hint unknown()
+        {return size_hint {UNKNOWN, 0};}
+
+        static size_hint estimate(size_t count)
+        {return size_hint {ESTIMATE, count};}
+
+        static size_hint lower_bound(size_t count)
+        {return size_hint {LOWER_BOUND, count};}
+
+        static size_hint exact(size_t count)
+        {return size_hint {EXACT, count};}
+
+        bool is_exact() const
+        {return kind == EXACT;}
+
+        kind_t kind;
+        size_t count;
+    };
+
     template <typename T, size_t MemSize, typename IteratorType>
     class _fwd_iter_impl_base
     {
@@ -50,6 +85,8 @@ namespace virtual_iter
 
         virtual void visit(void* iter, void* end_iter, std::function<bool(const T&)>&) = 0;
 
+        virtual size_hint remaining_hint(void* iter, void* end_iter) const = 0;
+
         void* mem(const iterator_type& arg) const
         {
             return arg.mem ();
@@ -71,6 +108,13 @@ namespace virtual_iter
         virtual iterator_type& minusminus(iterator_type& obj) = 0;        
         virtual iterator_type& pluseq(iterator_type& obj, difference_type incr) = 0;        
         virtual iterator_type& minuseq(iterator_type& obj, difference_type decr) = 0;                       
+
+        // Reverse counterparts of copy and visit. Elements before iter (back to begin_iter) are produced
+        // in reverse order, i.e. the element just before iter comes first, and iter is moved back past
+        // every element consumed.
+        virtual size_t copy_backward(T* resultPtr, size_t maxItems, void* iter, void* beginItr) const = 0;
+
+        virtual void visit_reverse(void* iter, void* begin_iter, std::function<bool(const T&)>&) = 0;
         using base_t::mem;        
     };
     
@@ -149,6 +193,12 @@ namespace virtual_iter
         {
             m_impl->visit (m_iter_mem, endItr.m_iter_mem, f);
         }        
+
+        // Number of elements left before endPos, for preallocating ahead of copy loops.
+        size_hint remaining_hint(const iterator_type& endPos) const
+        {
+            return m_impl->remaining_hint (m_iter_mem, endPos.m_iter_mem);
+        }
         
     protected:
         void* mem() const
@@ -233,5 +283,279 @@ namespace virtual_iter
     
         rand_iter& operator-=(difference_type decr)
         {return base_t::m_impl->minuseq(*this, decr);}              
+
+        // Copies up to maxItems elements preceding this iterator into resultPtr, nearest element first,
+        // stopping at beginPos.  This is the bulk path for "latest N entries" style queries.
+        size_t copy_backward(T* resultPtr, size_t maxItems, const rand_iter& beginPos) const
+        {
+            return base_t::m_impl->copy_backward (resultPtr, maxItems, base_t::m_iter_mem, beginPos.m_iter_mem);
+        }
+
+        void visit_reverse(const rand_iter& beginItr, std::function<bool(const value_type&)>& f)
+        {
+            base_t::m_impl->visit_reverse (base_t::m_iter_mem, beginItr.m_iter_mem, f);
+        }
     };    
+
+
+    // The write side counterpart of _fwd_iter_impl_base.  Implementations receive whole blocks of elements
+    // so the virtual call is paid once per block rather than once per element.
+    template <typename T>
+    class _out_iter_impl_base
+    {
+    public:
+        virtual ~_out_iter_impl_base()
+        {
+        }
+
+        virtual void write_block(const T* items, size_t count) = 0;
+    };
+
+
+    // Output iterator over an opaque destination.  Elements are staged in an inline buffer of MemSize bytes
+    // and handed to the impl through write_block when the buffer fills, on flush and on destruction.
+    // Copying an out_iter flushes the source first, so output stays in order as long as only one copy is
+    // written to at a time (which is how std algorithms use output iterators).
+    // The destructor cannot report errors and drops anything write_block throws, so call flush explicitly
+    // before the out_iter goes away when write errors (e.g. std::bad_alloc) must be seen.
+    template <typename T, size_t MemSize>
+    class out_iter
+    {
+    public:
+        typedef std::output_iterator_tag iterator_category;
+        typedef void value_type;
+        typedef ssize_t difference_type;
+        typedef void pointer;
+        typedef void reference;
+        typedef _out_iter_impl_base<T> base_impl_t;
+        static constexpr size_t buffer_size = MemSize / sizeof(T);
+
+        static_assert(buffer_size > 0, "virtual_iter::out_iter: MemSize too small to stage one element.");
+
+        template <typename Impl>
+        explicit out_iter(Impl impl):
+            m_impl(impl.create_out_iter_impl ()),
+            m_count(0)
+        {
+        }
+
+        out_iter(const out_iter& rhs):
+            m_impl(rhs.m_impl),
+            m_count(0)
+        {
+            rhs.flush ();
+        }
+
+        out_iter& operator=(const out_iter& rhs)
+        {
+            flush ();
+            rhs.flush ();
+            m_impl = rhs.m_impl;
+            return *this;
+        }
+
+        ~out_iter()
+        {
+            try
+            {
+                flush ();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        out_iter& operator*()
+        {return *this;}
+
+        out_iter& operator++()
+        {return *this;}
+
+        out_iter& operator++(int)
+        {return *this;}
+
+        out_iter& operator=(const T& value)
+        {
+            if (m_count == buffer_size)
+                flush ();
+
+            m_buffer[m_count++] = value;
+            return *this;
+        }
+
+        // Writes count elements.  Blocks at least as large as the staging buffer bypass it.
+        void write(const T* items, size_t count)
+        {
+            if (count >= buffer_size)
+            {
+                flush ();
+                m_impl->write_block (items, count);
+                return;
+            }
+
+            if (m_count + count > buffer_size)
+                flush ();
+
+            std::copy (items, items + count, m_buffer + m_count);
+            m_count += count;
+        }
+
+        void flush() const
+        {
+            if (m_count)
+            {
+                m_impl->write_block (m_buffer, m_count);
+                m_count = 0;
+            }
+        }
+
+    private:
+        std::shared_ptr<base_impl_t> m_impl;
+        mutable size_t m_count;
+        mutable T m_buffer[buffer_size];
+    };
+
+
+    // Presents [begin, end) of a rand_iter range in reverse order.  The iterator pulls BlockSize elements
+    // at a time via copy_backward so range-for and std algorithms pay one virtual call per block rather
+    // than a -- and a * per element.  T must be default constructible and copy assignable.
+    template <typename T, size_t MemSize, size_t BlockSize = 64>
+    class reverse_view
+    {
+    public:
+        typedef rand_iter<T, MemSize> rand_iter_t;
+        typedef T value_type;
+        typedef ssize_t difference_type;
+
+        class iterator
+        {
+        public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef ssize_t difference_type;
+            typedef const T* pointer;
+            typedef const T& reference;
+
+            iterator(const rand_iter_t& begin, const rand_iter_t& pos):
+                m_begin(begin),
+                m_pos(pos),
+                m_remaining(pos - begin),
+                m_buf_pos(0),
+                m_buf_count(0)
+            {
+                fill ();
+            }
+
+            const T& operator*() const
+            {return m_buf[m_buf_pos];}
+
+            const T* operator->() const
+            {return &m_buf[m_buf_pos];}
+
+            iterator& operator++()
+            {
+                --m_remaining;
+                if (++m_buf_pos == m_buf_count)
+                    fill ();
+                return *this;
+            }
+
+            bool operator==(const iterator& rhs) const
+            {return m_remaining == rhs.m_remaining;}
+
+            bool operator!=(const iterator& rhs) const
+            {return m_remaining != rhs.m_remaining;}
+
+        private:
+            void fill()
+            {
+                m_buf_pos = 0;
+                m_buf_count = m_remaining > 0 ? m_pos.copy_backward (m_buf, BlockSize, m_begin) : 0;
+            }
+
+            rand_iter_t m_begin;
+            rand_iter_t m_pos;
+            difference_type m_remaining;
+            size_t m_buf_pos;
+            size_t m_buf_count;
+            T m_buf[BlockSize];
+        };
+
+        reverse_view(const rand_iter_t& begin, const rand_iter_t& end):
+            m_begin(begin),
+            m_end(end)
+        {
+        }
+
+        iterator begin() const
+        {return iterator (m_begin, m_end);}
+
+        iterator end() const
+        {return iterator (m_begin, m_begin);}
+
+        difference_type size() const
+        {return m_end - m_begin;}
+
+        // Copies up to maxItems elements from the back of the range, last element first.
+        size_t copy(T* resultPtr, size_t maxItems) const
+        {
+            rand_iter_t pos (m_end);
+            return pos.copy_backward (resultPtr, maxItems, m_begin);
+        }
+
+        void visit(std::function<bool(const value_type&)>& f) const
+        {
+            rand_iter_t pos (m_end);
+            pos.visit_reverse (m_begin, f);
+        }
+
+    private:
+        rand_iter_t m_begin;
+        rand_iter_t m_end;
+    };
+
+
+    // Materializes [begin, end) into a vector.  The remaining_hint sizes the vector once when it is exact and
+    // seeds the reservation otherwise; the elements are then pulled through copy a block at a time.
+    // T must be default constructible.
+    template <typename IterType>
+    std::vector<typename IterType::value_type> to_vector(IterType begin, const IterType& end, size_t block_size = 1024)
+    {
+        std::vector<typename IterType::value_type> result;
+        size_hint hint = begin.remaining_hint (end);
+
+        if (hint.is_exact ())
+        {
+            result.resize (hint.count);
+            size_t copied = 0;
+            while (copied < hint.count)
+            {
+                size_t count = begin.copy (result.data () + copied, hint.count - copied, end);
+                if (count == 0)
+                    break;
+
+                copied += count;
+            }
+            result.resize (copied);
+            return result;
+        }
+
+        // Fill the reserved space before growing past it, so a hint that turns out right never reallocates.
+        result.reserve (hint.count);
+        for (;;)
+        {
+            size_t filled = result.size ();
+            size_t room = result.capacity () - filled;
+            if (room == 0 && begin == end)
+                break;
+
+            size_t request = room ? std::min (room, block_size) : block_size;
+            result.resize (filled + request);
+            size_t count = begin.copy (result.data () + filled, request, end);
+            result.resize (filled + count);
+            if (count == 0)
+                break;
+        }
+        return result;
+    }
 }
@@ -0,0 +1,303 @@
+/***********************************************************************************************************************
+ * virtual_iter:
+ * Iterator types for opaque sequence collections.
+ * Copyright 2020 Kuberan Naganathan
+ * Released under the terms of the MIT license:
+ * https://opensource.org/licenses/MIT
+ **********************************************************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <thread>
+
+#include "virtual_iter.h"
+
+namespace virtual_iter
+{
+    // Distributes a rand_iter range across worker threads.  Workers claim [i, i + k) blocks with a single
+    // atomic fetch_add and then bulk copy their block through a private iterator, so the shared state is
+    // one counter.  Block sizes shrink as the range drains to keep the tail balanced across workers.
+    //
+    // Usage: each thread constructs its own worker from the shared cursor and calls next until it returns 0.
+    template <typename T, size_t MemSize>
+    class shared_rand_cursor
+    {
+    public:
+        typedef rand_iter<T, MemSize> rand_iter_t;
+        typedef typename rand_iter_t::difference_type difference_type;
+
+        class worker
+        {
+        public:
+            worker(shared_rand_cursor& cursor):
+                m_cursor(cursor),
+                m_pos(cursor.m_begin),
+                m_offset(0)
+            {
+            }
+
+            // Claims the next block and copies it into result_ptr.  Returns 0 once the range is exhausted.
+            size_t next(T* result_ptr, size_t max_items)
+            {
+                size_t start = 0;
+                size_t count = 0;
+                if (!m_cursor.claim (max_items, start, count))
+                    return 0;
+
+                // pluseq moves the private iterator in place; copying m_begin here would hit the shared
+                // impl's reference count on every block.
+                m_pos += (difference_type) start - (difference_type) m_offset;
+                size_t copied = m_pos.copy (result_ptr, count, m_cursor.m_end);
+                m_offset = start + copied;
+                return copied;
+            }
+
+        private:
+            shared_rand_cursor& m_cursor;
+            rand_iter_t m_pos;
+            size_t m_offset;
+        };
+
+        shared_rand_cursor(const rand_iter_t& begin, const rand_iter_t& end, size_t num_workers,
+                           size_t min_block = 256):
+            m_begin(begin),
+            m_end(end),
+            m_size(std::max<difference_type> (end - begin, 0)),
+            m_num_workers(std::max<size_t> (num_workers, 1)),
+            m_min_block(std::max<size_t> (min_block, 1)),
+            m_next(0)
+        {
+        }
+
+        shared_rand_cursor(const shared_rand_cursor&) = delete;
+        shared_rand_cursor& operator=(const shared_rand_cursor&) = delete;
+
+        size_t size() const
+        {return m_size;}
+
+    private:
+        // Guided scheduling: hand out about half of each worker's fair share of what is left, bounded
+        // below by min_block and above by the caller's buffer.
+        bool claim(size_t max_items, size_t& start, size_t& count)
+        {
+            size_t claimed = m_next.load (std::memory_order_relaxed);
+            if (claimed >= m_size || max_items == 0)
+                return false;
+
+            size_t block = (m_size - claimed) / (2 * m_num_workers);
+            block = std::min (std::max (block, m_min_block), max_items);
+
+            start = m_next.fetch_add (block, std::memory_order_relaxed);
+            if (start >= m_size)
+                return false;
+
+            count = std::min (block, m_size - start);
+            return true;
+        }
+
+        const rand_iter_t m_begin;
+        const rand_iter_t m_end;
+        const size_t m_size;
+        const size_t m_num_workers;
+        const size_t m_min_block;
+        // Kept on its own cache line so the read-only members above are not invalidated on every claim.
+        alignas(64) std::atomic<size_t> m_next;
+    };
+
+
+    // Forward only sources cannot be split by index, so one filler thread owns the shared iterator and bulk
+    // copies batches into a bounded ring.  Each slot carries a sequence number: slot k of lap l is free for
+    // the filler when it holds k + l * slots and ready for its consumer when it holds one more.  Workers
+    // claim ring positions with a single fetch_add and wait on their own slot's sequence, so no worker ever
+    // blocks another and the filler only waits when the ring is full.  T must be default constructible.
+    //
+    // Usage: each thread constructs its own worker from the shared cursor and calls next until it returns 0.
+    // An exception thrown by the source is rethrown from next once the batches before it are drained.
+    template <typename T, size_t MemSize>
+    class shared_fwd_cursor
+    {
+        struct slot
+        {
+            alignas(64) std::atomic<size_t> m_seq;
+            size_t m_count;
+            std::unique_ptr<T[]> m_items;
+        };
+
+    public:
+        typedef fwd_iter<T, MemSize> fwd_iter_t;
+
+        class worker
+        {
+        public:
+            worker(shared_fwd_cursor& cursor):
+                m_cursor(cursor),
+                m_slot(nullptr),
+                m_ticket(0),
+                m_offset(0)
+            {
+            }
+
+            worker(const worker&) = delete;
+            worker& operator=(const worker&) = delete;
+
+            ~worker()
+            {
+                if (m_slot)
+                    m_cursor.release (*m_slot, m_ticket);
+            }
+
+            // Moves up to max_items of the claimed batch into result_ptr, claiming a new batch once the
+            // current one is used up.  Returns 0 once the range is exhausted.
+            size_t next(T* result_ptr, size_t max_items)
+            {
+                if (max_items == 0)
+                    return 0;
+
+                if (!m_slot)
+                {
+                    m_slot = m_cursor.acquire (m_ticket);
+                    if (!m_slot)
+                        return 0;
+
+                    m_offset = 0;
+                }
+
+                size_t count = std::min (max_items, m_slot->m_count - m_offset);
+                T* items = m_slot->m_items.get () + m_offset;
+                std::move (items, items + count, result_ptr);
+                m_offset += count;
+
+                if (m_offset == m_slot->m_count)
+                {
+                    m_cursor.release (*m_slot, m_ticket);
+                    m_slot = nullptr;
+                }
+                return count;
+            }
+
+        private:
+            shared_fwd_cursor& m_cursor;
+            slot* m_slot;
+            size_t m_ticket;
+            size_t m_offset;
+        };
+
+        shared_fwd_cursor(const fwd_iter_t& begin, const fwd_iter_t& end, size_t batch_size = 256,
+                          size_t num_slots = 64):
+            m_pos(begin),
+            m_end(end),
+            m_batch_size(std::max<size_t> (batch_size, 1)),
+            m_num_slots(std::max<size_t> (num_slots, 1)),
+            m_slots(new slot[m_num_slots]),
+            m_stop(false),
+            m_limit(std::numeric_limits<size_t>::max ()),
+            m_next(0)
+        {
+            for (size_t i = 0; i < m_num_slots; ++i)
+            {
+                m_slots[i].m_seq.store (i, std::memory_order_relaxed);
+                m_slots[i].m_count = 0;
+                m_slots[i].m_items.reset (new T[m_batch_size]);
+            }
+            m_filler = std::thread (&shared_fwd_cursor::fill, this);
+        }
+
+        shared_fwd_cursor(const shared_fwd_cursor&) = delete;
+        shared_fwd_cursor& operator=(const shared_fwd_cursor&) = delete;
+
+        // Workers must be gone before the cursor.  A filler waiting on a full ring is told to stop.
+        ~shared_fwd_cursor()
+        {
+            m_stop.store (true, std::memory_order_relaxed);
+            m_filler.join ();
+        }
+
+    private:
+        void fill()
+        {
+            size_t pos = 0;
+            try
+            {
+                for (;; ++pos)
+                {
+                    slot& s = m_slots[pos % m_num_slots];
+                    while (s.m_seq.load (std::memory_order_acquire) != pos)
+                    {
+                        if (m_stop.load (std::memory_order_relaxed))
+                        {
+                            m_limit.store (pos, std::memory_order_release);
+                            return;
+                        }
+                        std::this_thread::yield ();
+                    }
+
+                    size_t count = m_pos.copy (s.m_items.get (), m_batch_size, m_end);
+                    if (count == 0)
+                        break;
+
+                    s.m_count = count;
+                    s.m_seq.store (pos + 1, std::memory_order_release);
+                }
+            }
+            catch (...)
+            {
+                m_error = std::current_exception ();
+            }
+            m_limit.store (pos, std::memory_order_release);
+        }
+
+        // Claims the next ring position and waits for the filler to publish it.  Positions at or past the
+        // final limit get nullptr.
+        slot* acquire(size_t& ticket)
+        {
+            // Once the source is drained there is nothing left to claim, so skip the shared write.
+            size_t limit = m_limit.load (std::memory_order_acquire);
+            if (m_next.load (std::memory_order_relaxed) >= limit)
+                return finished ();
+
+            ticket = m_next.fetch_add (1, std::memory_order_relaxed);
+            slot& s = m_slots[ticket % m_num_slots];
+            while (s.m_seq.load (std::memory_order_acquire) != ticket + 1)
+            {
+                // The filler publishes every position below the limit before storing it, so a ticket under
+                // the limit is only waiting on a slot that is about to be filled.
+                if (ticket >= m_limit.load (std::memory_order_acquire))
+                    return finished ();
+
+                std::this_thread::yield ();
+            }
+            return &s;
+        }
+
+        // Hands the slot back to the filler for its next lap.
+        void release(slot& s, size_t ticket)
+        {
+            s.m_seq.store (ticket + m_num_slots, std::memory_order_release);
+        }
+
+        slot* finished() const
+        {
+            if (m_error)
+                std::rethrow_exception (m_error);
+
+            return nullptr;
+        }
+
+        fwd_iter_t m_pos;
+        const fwd_iter_t m_end;
+        const size_t m_batch_size;
+        const size_t m_num_slots;
+        std::unique_ptr<slot[]> m_slots;
+        // Written by the filler before it publishes m_limit, read by workers after they observe it.
+        std::exception_ptr m_error;
+        std::atomic<bool> m_stop;
+        // Ring positions the filler has published in total, known only once it has finished.
+        alignas(64) std::atomic<size_t> m_limit;
+        alignas(64) std::atomic<size_t> m_next;
+        std::thread m_filler;
+    };
+}
@@ -0,0 +1,310 @@
+/***********************************************************************************************************************
+ * virtual_iter:
+ * Iterator types for opaque sequence collections.
+ * Copyright 2020 Kuberan Naganathan
+ * Released under the terms of the MIT license:
+ * https://opensource.org/licenses/MIT
+ **********************************************************************************************************************/
+#pragma once
+
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <variant>
+
+#include "virtual_iter.h"
+#include "virtual_std_iter_detail.h"
+
+namespace virtual_iter
+{
+    // Static dispatch counterpart of the std impls.  When the set of wrapped iterator types is closed and
+    // known at build time the wrapped iterator is held in a std::variant and every operation dispatches
+    // through std::visit, which the compiler can turn into an inlined switch.  The impl is not polymorphic
+    // but exposes the same member functions as _fwd_iter_impl_base and _rand_iter_impl_base, so
+    // iter_base drives it unchanged.  Operations are only instantiated when used, which lets the forward
+    // flavor wrap iterators that lack operator- or operator+.
+    template <typename T, size_t MemSize, typename IterType, typename ConstIterList>
+    class _static_iter_impl;
+
+
+    template <typename T, size_t MemSize, typename IterType, typename ... ConstIters>
+    class _static_iter_impl<T, MemSize, IterType, virtual_iter_detail::type_list<ConstIters...>>
+    {
+    public:
+        typedef IterType iterator_type;
+        typedef ssize_t difference_type;
+        typedef std::variant<ConstIters...> variant_t;
+
+        static_assert(sizeof(variant_t) <= MemSize, "_static_iter_impl: MemSize too small.");
+        static_assert((std::is_same<typename std::iterator_traits<ConstIters>::value_type, T>::value && ...),
+                      "_static_iter_impl: every wrapped iterator must have value_type T");
+
+        // The impl is stateless so every iterator shares one instance.  The shared_ptr is built with the
+        // aliasing constructor around an empty owner, so copying iterators never touches a reference count.
+        static const std::shared_ptr<_static_iter_impl>& shared()
+        {
+            static _static_iter_impl instance;
+            static const std::shared_ptr<_static_iter_impl> ptr (std::shared_ptr<void>(), &instance);
+            return ptr;
+        }
+
+        template <typename WrappedIter>
+        void instantiate(iterator_type& arg, WrappedIter& itr) const
+        {
+            new (arg.mem ()) variant_t (itr);
+        }
+
+        void instantiate(iterator_type& lhs, const iterator_type& rhs) const
+        {
+            new (lhs.mem ()) variant_t (store (rhs));
+        }
+
+        void destroy(iterator_type& obj) const
+        {
+            store (obj).~variant_t();
+        }
+
+        iterator_type& plusplus(iterator_type& obj) const
+        {
+            std::visit ([](auto& itr) { ++itr; }, store (obj));
+            return obj;
+        }
+
+        bool equals(const iterator_type& lhs, const iterator_type& rhs) const
+        {
+            return store (lhs) == store (rhs);
+        }
+
+        difference_type distance(const iterator_type& lhs, const iterator_type& rhs) const
+        {
+            const variant_t& rhs_store = store (rhs);
+            return std::visit ([&rhs_store](const auto& itr) -> difference_type {
+                return itr - std::get<std::decay_t<decltype(itr)>> (rhs_store);
+            }, store (lhs));
+        }
+
+        iterator_type plus(const iterator_type& lhs, difference_type offset) const
+        {
+            return std::visit ([offset](const auto& itr) { return iterator_type (itr + offset); }, store (lhs));
+        }
+
+        iterator_type minus(const iterator_type& lhs, difference_type offset) const
+        {
+            return std::visit ([offset](const auto& itr) { return iterator_type (itr - offset); }, store (lhs));
+        }
+
+        const T* pointer(const iterator_type& arg) const
+        {
+            return std::visit ([](const auto& itr) { return &*itr; }, store (arg));
+        }
+
+        const T& reference(const iterator_type& arg) const
+        {
+            return std::visit ([](const auto& itr) -> const T& { return *itr; }, store (arg));
+        }
+
+        size_t copy(T* result_ptr, size_t max_items, void* iter, void* end_iter) const
+        {
+            const variant_t& end_store = *reinterpret_cast<variant_t*>(end_iter);
+            return std::visit ([&](auto& itr) -> size_t {
+                using wrapped_t = std::decay_t<decltype(itr)>;
+                const wrapped_t& end_itr = std::get<wrapped_t> (end_store);
+                size_t copy_count = 0;
+
+                if constexpr (std::is_same<typename std::iterator_traits<wrapped_t>::iterator_category,
+                                           std::random_access_iterator_tag>::value)
+                {
+                    difference_type distance_to_end = end_itr - itr;
+                    if (distance_to_end <= 0)
+                        return 0;
+
+                    if (distance_to_end < (difference_type) max_items)
+                        max_items = (size_t) distance_to_end;
+                }
+
+                while (copy_count < max_items && itr != end_itr)
+                {
+                    *result_ptr++ = *itr++;
+                    ++copy_count;
+                }
+                return copy_count;
+            }, *reinterpret_cast<variant_t*>(iter));
+        }
+
+        void visit(void* iter, void* end_iter, std::function<bool(const T&)>& f) const
+        {
+            const variant_t& end_store = *reinterpret_cast<variant_t*>(end_iter);
+            std::visit ([&](auto& itr) {
+                const auto& end_itr = std::get<std::decay_t<decltype(itr)>> (end_store);
+                for (; itr != end_itr; ++itr)
+                {
+                    if (!f (*itr))
+                        return;
+                }
+            }, *reinterpret_cast<variant_t*>(iter));
+        }
+
+        // Exact for random access alternatives, unknown for the rest since counting would walk the range.
+        size_hint remaining_hint(void* iter, void* end_iter) const
+        {
+            const variant_t& end_store = *reinterpret_cast<variant_t*>(end_iter);
+            return std::visit ([&end_store](const auto& itr) -> size_hint {
+                using wrapped_t = std::decay_t<decltype(itr)>;
+                if constexpr (std::is_same<typename std::iterator_traits<wrapped_t>::iterator_category,
+                                           std::random_access_iterator_tag>::value)
+                {
+                    difference_type distance_to_end = std::get<wrapped_t> (end_store) - itr;
+                    return size_hint::exact (distance_to_end > 0 ? (size_t) distance_to_end : 0);
+                }
+                else
+                {
+                    return size_hint::unknown ();
+                }
+            }, *reinterpret_cast<variant_t*>(iter));
+        }
+
+        iterator_type& minusminus(iterator_type& obj) const
+        {
+            std::visit ([](auto& itr) { --itr; }, store (obj));
+            return obj;
+        }
+
+        iterator_type& pluseq(iterator_type& obj, difference_type incr) const
+        {
+            std::visit ([incr](auto& itr) { itr += incr; }, store (obj));
+            return obj;
+        }
+
+        iterator_type& minuseq(iterator_type& obj, difference_type decr) const
+        {
+            std::visit ([decr](auto& itr) { itr -= decr; }, store (obj));
+            return obj;
+        }
+
+        size_t copy_backward(T* result_ptr, size_t max_items, void* iter, void* begin_iter) const
+        {
+            const variant_t& begin_store = *reinterpret_cast<variant_t*>(begin_iter);
+            return std::visit ([&](auto& itr) -> size_t {
+                difference_type distance_to_begin = itr - std::get<std::decay_t<decltype(itr)>> (begin_store);
+                if (distance_to_begin <= 0)
+                    return 0;
+
+                if (distance_to_begin < (difference_type) max_items)
+                    max_items = (size_t) distance_to_begin;
+
+                for (size_t i = 0; i < max_items; ++i)
+                    *result_ptr++ = *--itr;
+                return max_items;
+            }, *reinterpret_cast<variant_t*>(iter));
+        }
+
+        void visit_reverse(void* iter, void* begin_iter, std::function<bool(const T&)>& f) const
+        {
+            const variant_t& begin_store = *reinterpret_cast<variant_t*>(begin_iter);
+            std::visit ([&](auto& itr) {
+                const auto& begin_itr = std::get<std::decay_t<decltype(itr)>> (begin_store);
+                for (; itr != begin_itr; --itr)
+                {
+                    if (!f (*std::prev (itr)))
+                        return;
+                }
+            }, *reinterpret_cast<variant_t*>(iter));
+        }
+
+    private:
+        static variant_t& store(const iterator_type& arg)
+        {
+            return *reinterpret_cast<variant_t*>(arg.mem ());
+        }
+    };
+
+
+    // Forward iterator over a closed set of wrapped iterator types, e.g.
+    // static_fwd_iter<int, 48, virtual_iter_detail::type_list<std::vector<int>::const_iterator,
+    //                                                         std::deque<int>::const_iterator>>
+    template <typename T, size_t MemSize, typename ConstIterList>
+    class static_fwd_iter: public iter_base<T, MemSize, static_fwd_iter<T, MemSize, ConstIterList>,
+                                            _static_iter_impl<T, MemSize, static_fwd_iter<T, MemSize, ConstIterList>, ConstIterList>>
+    {
+    public:
+        typedef iter_base<T, MemSize, static_fwd_iter<T, MemSize, ConstIterList>,
+                          _static_iter_impl<T, MemSize, static_fwd_iter<T, MemSize, ConstIterList>, ConstIterList>> base_t;
+        typedef std::forward_iterator_tag iterator_category;
+        using value_type = typename base_t::value_type;
+        using difference_type = typename base_t::difference_type;
+        using pointer = typename base_t::pointer;
+        using reference = typename base_t::reference;
+        using base_impl_t = typename base_t::base_impl_t;
+
+        template <typename WrappedIter>
+        explicit static_fwd_iter(WrappedIter iter):
+            base_t(base_impl_t::shared ())
+        {
+            base_t::m_impl->instantiate (*this, iter);
+        }
+
+        static_fwd_iter(const static_fwd_iter& rhs):
+            base_t(rhs.m_impl)
+        {
+            base_t::m_impl->instantiate (*this, rhs);
+        }
+
+        ~static_fwd_iter()
+        {
+            base_t::m_impl->destroy (*this);
+        }
+    };
+
+
+    template <typename T, size_t MemSize, typename ConstIterList>
+    class static_rand_iter: public iter_base<T, MemSize, static_rand_iter<T, MemSize, ConstIterList>,
+                                             _static_iter_impl<T, MemSize, static_rand_iter<T, MemSize, ConstIterList>, ConstIterList>>
+    {
+    public:
+        typedef iter_base<T, MemSize, static_rand_iter<T, MemSize, ConstIterList>,
+                          _static_iter_impl<T, MemSize, static_rand_iter<T, MemSize, ConstIterList>, ConstIterList>> base_t;
+        typedef std::random_access_iterator_tag iterator_category;
+        using value_type = typename base_t::value_type;
+        using difference_type = typename base_t::difference_type;
+        using pointer = typename base_t::pointer;
+        using reference = typename base_t::reference;
+        using base_impl_t = typename base_t::base_impl_t;
+
+        template <typename WrappedIter>
+        explicit static_rand_iter(WrappedIter iter):
+            base_t(base_impl_t::shared ())
+        {
+            base_t::m_impl->instantiate (*this, iter);
+        }
+
+        static_rand_iter(const static_rand_iter& rhs):
+            base_t(rhs.m_impl)
+        {
+            base_t::m_impl->instantiate (*this, rhs);
+        }
+
+        ~static_rand_iter()
+        {
+            base_t::m_impl->destroy (*this);
+        }
+
+        static_rand_iter& operator--()
+        {return base_t::m_impl->minusminus (*this);}
+
+        static_rand_iter& operator+=(difference_type incr)
+        {return base_t::m_impl->pluseq (*this, incr);}
+
+        static_rand_iter& operator-=(difference_type decr)
+        {return base_t::m_impl->minuseq (*this, decr);}
+
+        size_t copy_backward(T* resultPtr, size_t maxItems, const static_rand_iter& beginPos) const
+        {
+            return base_t::m_impl->copy_backward (resultPtr, maxItems, base_t::m_iter_mem, beginPos.m_iter_mem);
+        }
+
+        void visit_reverse(const static_rand_iter& beginItr, std::function<bool(const value_type&)>& f)
+        {
+            base_t::m_impl->visit_reverse (base_t::m_iter_mem, beginItr.m_iter_mem, f);
+        }
+    };
+}
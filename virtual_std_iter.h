@@ -9,6 +9,11 @@
 
 #include "virtual_iter.h"
 #include "virtual_std_iter_detail.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
 #include <type_traits>
 
 namespace virtual_iter
@@ -121,6 +126,14 @@ namespace virtual_iter
                 ++lhs_iter->m_itr;
             }
         }
+
+        size_hint remaining_hint(void* iter, void* end_iter) const override
+        {
+            auto lhs_iter = reinterpret_cast<_IterStore*>(iter);
+            auto rhs_iter = reinterpret_cast<_IterStore*>(end_iter);
+            ssize_t distance_to_end = rhs_iter->m_itr - lhs_iter->m_itr;
+            return size_hint::exact (distance_to_end > 0 ? (size_t) distance_to_end : 0);
+        }
     };
 
 
@@ -246,6 +259,587 @@ namespace virtual_iter
             auto iter_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (lhs));            
             return iterator_type (std_rand_iter_impl(), iter_store->m_itr - offset);
         }
+
+        // When the wrapped iterator walks contiguous storage of a trivially copyable type the block is
+        // reversed straight out of memory, which the compiler is able to vectorize.
+        size_t copy_backward(value_type* result_ptr, size_t max_items, void* iter, void* begin_iter) const override
+        {
+            auto cur_iter = reinterpret_cast<_IterStore*>(iter);
+            auto first_iter = reinterpret_cast<_IterStore*>(begin_iter);
+            difference_type distance_to_begin = cur_iter->m_itr - first_iter->m_itr;
+
+            if (distance_to_begin <= 0)
+                return 0;
+
+            if (distance_to_begin < (difference_type) max_items)
+                max_items = (size_t) distance_to_begin;
+
+            if constexpr (virtual_iter_detail::is_contiguous_iterator<ConstIterType>::value &&
+                          std::is_trivially_copyable<value_type>::value)
+            {
+                const value_type* src = &*(cur_iter->m_itr - max_items);
+                std::reverse_copy (src, src + max_items, result_ptr);
+                cur_iter->m_itr -= max_items;
+            }
+            else
+            {
+                for (size_t i = 0; i < max_items; ++i)
+                    *result_ptr++ = *--cur_iter->m_itr;
+            }
+            return max_items;
+        }
+
+        void visit_reverse(void* iter, void* begin_iter, std::function<bool(const value_type&)>& f) override
+        {
+            auto cur_iter = reinterpret_cast<_IterStore*>(iter);
+            auto first_iter = reinterpret_cast<_IterStore*>(begin_iter);
+
+            for (difference_type diff = cur_iter->m_itr - first_iter->m_itr; diff > 0; --diff)
+            {
+                if (!f (*std::prev (cur_iter->m_itr)))
+                    return;
+
+                --cur_iter->m_itr;
+            }
+        }
+    };
+
+
+    // Implementation of fwd_iter for unordered containers (std::unordered_map/set and flat_hash_map) and any
+    // other container whose iterators only support ++.  Each iterator remembers how many elements remained
+    // before the container's end when it was created, which gives an O(1) distance without operator-.
+    // Containers whose iterators provide scan_n are copied and visited block wise through it.  The impl keeps
+    // a pointer to the container so size() is O(1) for callers that want to preallocate.
+    //
+    // The cached counts are not updated when the container changes, so after an insert or erase distance
+    // is stale.  Bulk operations only use them as a hint; every walk stops at the end iterator.
+    template <typename ContainerType, size_t IterMemSize, typename IterType=fwd_iter<typename ContainerType::value_type, IterMemSize> >
+    class std_unordered_iter_impl: virtual public _fwd_iter_impl_base<typename ContainerType::value_type, IterMemSize, IterType>
+    {
+    public:
+        typedef typename ContainerType::value_type value_type;
+        typedef typename ContainerType::const_iterator const_iterator;
+        typedef _fwd_iter_impl_base<value_type, IterMemSize, IterType> impl_base_t;
+        typedef std::shared_ptr<impl_base_t> shared_base_t;
+        typedef IterType iterator_type;
+        using difference_type = typename impl_base_t::difference_type;
+
+        struct _IterStore
+        {
+            const_iterator m_itr;
+            size_t m_remaining;
+
+            _IterStore(const const_iterator& itr, size_t remaining):
+                m_itr (itr),
+                m_remaining (remaining)
+            {
+            }
+        };
+
+        std_unordered_iter_impl(const ContainerType& container):
+            m_container(&container)
+        {
+        }
+
+        template <typename WrappedIter>
+        shared_base_t create_fwd_iter_impl(WrappedIter& iter)
+        {
+            return std::make_shared<std_unordered_iter_impl<ContainerType, IterMemSize, IterType>>(*this);
+        }
+
+        // Wrapping begin or end is O(1).  Any other position costs one walk to the end to count what remains.
+        template <typename WrappedIter>
+        void instantiate(iterator_type& arg, WrappedIter& itr)
+        {
+            static_assert (sizeof (_IterStore) <= IterMemSize, "std_unordered_iter_impl: IterMemSize too small.");
+            const_iterator pos (itr);
+            size_t remaining = 0;
+            if (pos == m_container->begin ())
+                remaining = m_container->size ();
+            else if (pos != m_container->end ())
+                remaining = (size_t) std::distance (pos, m_container->end ());
+
+            new (impl_base_t::mem (arg)) _IterStore (pos, remaining);
+        }
+
+        void instantiate(iterator_type& lhs, const iterator_type& rhs) const override
+        {
+            auto rhs_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (rhs));
+            new (impl_base_t::mem (lhs)) _IterStore (*rhs_store);
+        }
+
+        size_t size() const
+        {return m_container->size ();}
+
+        iterator_type& plusplus(iterator_type& obj) override
+        {
+            auto iter_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (obj));
+            ++iter_store->m_itr;
+            if (iter_store->m_remaining)
+                --iter_store->m_remaining;
+            return obj;
+        }
+
+        void destroy(iterator_type& obj) const override
+        {
+            reinterpret_cast<_IterStore*>(impl_base_t::mem (obj))->~_IterStore();
+        }
+
+        bool equals(const iterator_type& lhs, const iterator_type& rhs) const override
+        {
+            auto lhs_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (lhs));
+            auto rhs_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (rhs));
+            return lhs_store->m_itr == rhs_store->m_itr;
+        }
+
+        difference_type distance(const iterator_type& lhs, const iterator_type& rhs) const override
+        {
+            auto lhs_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (lhs));
+            auto rhs_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (rhs));
+            return (difference_type) rhs_store->m_remaining - (difference_type) lhs_store->m_remaining;
+        }
+
+        // Forward iterators cannot step back so both plus and minus are resolved by walking from begin.
+        iterator_type plus(const iterator_type& lhs, difference_type offset) const override
+        {
+            auto iter_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (lhs));
+            if (offset >= 0)
+            {
+                iterator_type result (lhs);
+                auto result_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (result));
+                std::advance (result_store->m_itr, offset);
+                result_store->m_remaining -= offset;
+                return result;
+            }
+            difference_type position = (difference_type) (m_container->size () - iter_store->m_remaining) + offset;
+            return iterator_type (*this, std::next (m_container->begin (), position));
+        }
+
+        iterator_type minus(const iterator_type& lhs, difference_type offset) const override
+        {
+            return plus (lhs, -offset);
+        }
+
+        const value_type* pointer(const iterator_type& arg) const override
+        {
+            auto iter_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (arg));
+            return &*iter_store->m_itr;
+        }
+
+        const value_type& reference(const iterator_type& arg) const override
+        {
+            auto iter_store = reinterpret_cast<_IterStore*>(impl_base_t::mem (arg));
+            return *iter_store->m_itr;
+        }
+
+        size_t copy(value_type* result_ptr, size_t max_items, void* iter, void* end_iter) const override
+        {
+            auto lhs_iter = reinterpret_cast<_IterStore*>(iter);
+            const const_iterator& end_itr = reinterpret_cast<_IterStore*>(end_iter)->m_itr;
+            size_t count = 0;
+
+            if constexpr (virtual_iter_detail::has_scan_n<const_iterator>::value)
+            {
+                count = lhs_iter->m_itr.scan_n (max_items, end_itr, [&result_ptr](const value_type& value) {
+                    virtual_iter_detail::assign_element (*result_ptr++, value);
+                    return true;
+                });
+            }
+            else
+            {
+                for (; count < max_items && lhs_iter->m_itr != end_itr; ++count, ++lhs_iter->m_itr)
+                    virtual_iter_detail::assign_element (*result_ptr++, *lhs_iter->m_itr);
+            }
+            consume (lhs_iter, count);
+            return count;
+        }
+
+        void visit(void* iter, void* end_iter, std::function<bool(const value_type&)>& f) override
+        {
+            auto lhs_iter = reinterpret_cast<_IterStore*>(iter);
+            const const_iterator& end_itr = reinterpret_cast<_IterStore*>(end_iter)->m_itr;
+
+            if constexpr (virtual_iter_detail::has_scan_n<const_iterator>::value)
+            {
+                consume (lhs_iter, lhs_iter->m_itr.scan_n ((size_t) -1, end_itr, f));
+            }
+            else
+            {
+                for (; lhs_iter->m_itr != end_itr; ++lhs_iter->m_itr)
+                {
+                    if (!f (*lhs_iter->m_itr))
+                        return;
+
+                    consume (lhs_iter, 1);
+                }
+            }
+        }
+
+        // The cached counts go stale when the container changes so they can only be offered as an estimate.
+        size_hint remaining_hint(void* iter, void* end_iter) const override
+        {
+            return size_hint::estimate (items_between (reinterpret_cast<_IterStore*>(iter), reinterpret_cast<_IterStore*>(end_iter)));
+        }
+
+    private:
+        static void consume(_IterStore* store, size_t count)
+        {
+            store->m_remaining -= std::min (store->m_remaining, count);
+        }
+
+        static size_t items_between(const _IterStore* lhs, const _IterStore* rhs)
+        {
+            return lhs->m_remaining > rhs->m_remaining ? lhs->m_remaining - rhs->m_remaining : 0;
+        }
+
+        const ContainerType* m_container;
+    };
+
+
+    // Identity and generation of a container whose iterators are wrapped by the checked impls below.
+    // The owner calls invalidate whenever it does something that invalidates iterators (reallocation,
+    // erase, clear ...).  Iterators remember the generation they were created in.
+    class iter_generation
+    {
+    public:
+        iter_generation():
+            m_generation(0)
+        {
+        }
+
+        iter_generation(const iter_generation&) = delete;
+        iter_generation& operator=(const iter_generation&) = delete;
+
+        void invalidate()
+        {m_generation.fetch_add (1, std::memory_order_release);}
+
+        size_t current() const
+        {return m_generation.load (std::memory_order_acquire);}
+
+    private:
+        std::atomic<size_t> m_generation;
+    };
+
+
+    class checked_iter_error: public std::logic_error
+    {
+    public:
+        using std::logic_error::logic_error;
+    };
+
+
+    // Iterator storage for the checked impls.  The wrapped iterator stays at the front so the unchecked
+    // per element operations inherited from the std impls work on it untouched.
+    template <typename IterStore>
+    struct _checked_iter_store: public IterStore
+    {
+        template <typename IteratorType>
+        _checked_iter_store(IteratorType& itr, const iter_generation* owner, size_t generation):
+            IterStore(itr),
+            m_owner(owner),
+            m_generation(generation)
+        {
+        }
+
+        // Validates a [lhs, rhs) pair handed to a bulk operation.
+        static void check_range(const _checked_iter_store* lhs, const _checked_iter_store* rhs)
+        {
+            if (lhs->m_owner != rhs->m_owner)
+                throw checked_iter_error ("virtual_iter: iterators belong to different containers");
+
+            size_t current = lhs->m_owner->current ();
+            if (lhs->m_generation != current || rhs->m_generation != current)
+                throw checked_iter_error ("virtual_iter: iterator used after its container was invalidated");
+
+            if (rhs->m_itr - lhs->m_itr < 0)
+                throw checked_iter_error ("virtual_iter: range end precedes range begin");
+        }
+
+        const iter_generation* m_owner;
+        size_t m_generation;
+    };
+
+
+    // Opt-in checked variants of the std impls.  Every iterator is tagged with its container's
+    // iter_generation and the generation it was created in.  Only the bulk operations (copy, visit and
+    // their reverse counterparts) verify the tags so per element operations cost the same as unchecked.
+    template <typename ConstIterType, size_t IterMemSize, typename IterType=fwd_iter<typename ConstIterType::value_type, IterMemSize> >
+    class checked_std_fwd_iter_impl: public std_fwd_iter_impl<ConstIterType, IterMemSize, IterType>
+    {
+    public:
+        typedef std_fwd_iter_impl<ConstIterType, IterMemSize, IterType> std_impl_t;
+        typedef typename ConstIterType::value_type value_type;
+        typedef typename std_impl_t::impl_base_t impl_base_t;
+        typedef typename std_impl_t::shared_base_t shared_base_t;
+        typedef IterType iterator_type;
+        using difference_type = typename impl_base_t::difference_type;
+        typedef _checked_iter_store<typename std_impl_t::_IterStore> _CheckedStore;
+
+        checked_std_fwd_iter_impl(const iter_generation& owner):
+            m_owner(&owner)
+        {
+        }
+
+        template <typename WrappedIter>
+        shared_base_t create_fwd_iter_impl(WrappedIter& iter)
+        {
+            return std::make_shared<checked_std_fwd_iter_impl<ConstIterType, IterMemSize, IterType>>(*this);
+        }
+
+        template <typename WrappedIter>
+        void instantiate(iterator_type& arg, WrappedIter& itr)
+        {
+            static_assert (sizeof (_CheckedStore) <= IterMemSize, "checked_std_fwd_iter_impl: IterMemSize too small.");
+            new (impl_base_t::mem (arg)) _CheckedStore (itr, m_owner, m_owner->current ());
+        }
+
+        void instantiate(iterator_type& lhs, const iterator_type& rhs) const override
+        {
+            auto rhs_store = reinterpret_cast<_CheckedStore*>(impl_base_t::mem (rhs));
+            new (impl_base_t::mem (lhs)) _CheckedStore (*rhs_store);
+        }
+
+        void destroy(iterator_type& obj) const override
+        {
+            reinterpret_cast<_CheckedStore*>(impl_base_t::mem (obj))->~_CheckedStore();
+        }
+
+        iterator_type plus(const iterator_type& lhs, difference_type offset) const override
+        {
+            auto lhs_store = reinterpret_cast<_CheckedStore*>(impl_base_t::mem (lhs));
+            return derived (lhs_store, lhs_store->m_itr + offset);
+        }
+
+        iterator_type minus(const iterator_type& lhs, difference_type offset) const override
+        {
+            auto lhs_store = reinterpret_cast<_CheckedStore*>(impl_base_t::mem (lhs));
+            return derived (lhs_store, lhs_store->m_itr - offset);
+        }
+
+        size_t copy(value_type* result_ptr, size_t max_items, void* iter, void* end_iter) const override
+        {
+            _CheckedStore::check_range (reinterpret_cast<_CheckedStore*>(iter), reinterpret_cast<_CheckedStore*>(end_iter));
+            return std_impl_t::copy (result_ptr, max_items, iter, end_iter);
+        }
+
+        void visit(void* iter, void* end_iter, std::function<bool(const value_type&)>& f) override
+        {
+            _CheckedStore::check_range (reinterpret_cast<_CheckedStore*>(iter), reinterpret_cast<_CheckedStore*>(end_iter));
+            std_impl_t::visit (iter, end_iter, f);
+        }
+
+        size_hint remaining_hint(void* iter, void* end_iter) const override
+        {
+            _CheckedStore::check_range (reinterpret_cast<_CheckedStore*>(iter), reinterpret_cast<_CheckedStore*>(end_iter));
+            return std_impl_t::remaining_hint (iter, end_iter);
+        }
+
+    private:
+        // An iterator derived from another keeps its source's generation so staleness propagates.
+        iterator_type derived(const _CheckedStore* source, ConstIterType itr) const
+        {
+            iterator_type result (*this, itr);
+            reinterpret_cast<_CheckedStore*>(impl_base_t::mem (result))->m_generation = source->m_generation;
+            return result;
+        }
+
+        const iter_generation* m_owner;
+    };
+
+
+    template <typename ConstIterType, size_t IterMemSize, typename IterType=rand_iter<typename ConstIterType::value_type, IterMemSize>>
+    class checked_std_rand_iter_impl: public std_rand_iter_impl<ConstIterType, IterMemSize, IterType>
+    {
+    public:
+        typedef std_rand_iter_impl<ConstIterType, IterMemSize, IterType> std_impl_t;
+        typedef typename ConstIterType::value_type value_type;
+        typedef typename std_impl_t::impl_base_t impl_base_t;
+        typedef typename std_impl_t::shared_base_t shared_base_t;
+        typedef typename std_impl_t::fwd_impl_base_t fwd_impl_base_t;
+        typedef IterType iterator_type;
+        using difference_type = typename std_impl_t::difference_type;
+        typedef _checked_iter_store<typename std_impl_t::_IterStore> _CheckedStore;
+
+        checked_std_rand_iter_impl(const iter_generation& owner):
+            m_owner(&owner)
+        {
+        }
+
+        template <typename IteratorType>
+        shared_base_t create_rand_iter_impl(IteratorType& iter)
+        {
+            return std::make_shared<checked_std_rand_iter_impl<ConstIterType, IterMemSize, IterType>>(*this);
+        }
+
+        template <typename IteratorType>
+        void instantiate(iterator_type& arg, IteratorType& itr)
+        {
+            static_assert (sizeof (_CheckedStore) <= IterMemSize, "checked_std_rand_iter_impl: IterMemSize too small.");
+            new (impl_base_t::mem (arg)) _CheckedStore (itr, m_owner, m_owner->current ());
+        }
+
+        void instantiate(iterator_type& lhs, const iterator_type& rhs) const override
+        {
+            auto rhs_store = reinterpret_cast<_CheckedStore*>(impl_base_t::mem (rhs));
+            new (impl_base_t::mem (lhs)) _CheckedStore (*rhs_store);
+        }
+
+        void destroy(iterator_type& obj) const override
+        {
+            reinterpret_cast<_CheckedStore*>(impl_base_t::mem (obj))->~_CheckedStore();
+        }
+
+        iterator_type plus(const iterator_type& lhs, difference_type offset) const override
+        {
+            auto lhs_store = reinterpret_cast<_CheckedStore*>(impl_base_t::mem (lhs));
+            return derived (lhs_store, lhs_store->m_itr + offset);
+        }
+
+        iterator_type minus(const iterator_type& lhs, difference_type offset) const override
+        {
+            auto lhs_store = reinterpret_cast<_CheckedStore*>(impl_base_t::mem (lhs));
+            return derived (lhs_store, lhs_store->m_itr - offset);
+        }
+
+        size_t copy(value_type* result_ptr, size_t max_items, void* iter, void* end_iter) const override
+        {
+            _CheckedStore::check_range (reinterpret_cast<_CheckedStore*>(iter), reinterpret_cast<_CheckedStore*>(end_iter));
+            return fwd_impl_base_t::copy (result_ptr, max_items, iter, end_iter);
+        }
+
+        void visit(void* iter, void* end_iter, std::function<bool(const value_type&)>& f) override
+        {
+            _CheckedStore::check_range (reinterpret_cast<_CheckedStore*>(iter), reinterpret_cast<_CheckedStore*>(end_iter));
+            fwd_impl_base_t::visit (iter, end_iter, f);
+        }
+
+        size_hint remaining_hint(void* iter, void* end_iter) const override
+        {
+            _CheckedStore::check_range (reinterpret_cast<_CheckedStore*>(iter), reinterpret_cast<_CheckedStore*>(end_iter));
+            return fwd_impl_base_t::remaining_hint (iter, end_iter);
+        }
+
+        size_t copy_backward(value_type* result_ptr, size_t max_items, void* iter, void* begin_iter) const override
+        {
+            _CheckedStore::check_range (reinterpret_cast<_CheckedStore*>(begin_iter), reinterpret_cast<_CheckedStore*>(iter));
+            return std_impl_t::copy_backward (result_ptr, max_items, iter, begin_iter);
+        }
+
+        void visit_reverse(void* iter, void* begin_iter, std::function<bool(const value_type&)>& f) override
+        {
+            _CheckedStore::check_range (reinterpret_cast<_CheckedStore*>(begin_iter), reinterpret_cast<_CheckedStore*>(iter));
+            std_impl_t::visit_reverse (iter, begin_iter, f);
+        }
+
+    private:
+        iterator_type derived(const _CheckedStore* source, ConstIterType itr) const
+        {
+            iterator_type result (*this, itr);
+            reinterpret_cast<_CheckedStore*>(impl_base_t::mem (result))->m_generation = source->m_generation;
+            return result;
+        }
+
+        const iter_generation* m_owner;
+    };
+
+
+    // out_iter impl appending to a container.  Containers with reserve are grown geometrically ahead of the
+    // block, then the block goes in through one range insert, which for contiguous containers of trivially
+    // copyable types is a single memmove.
+    template <typename ContainerType>
+    class std_back_insert_out_impl: public _out_iter_impl_base<typename ContainerType::value_type>
+    {
+    public:
+        typedef typename ContainerType::value_type value_type;
+        typedef _out_iter_impl_base<value_type> impl_base_t;
+        typedef std::shared_ptr<impl_base_t> shared_base_t;
+
+        std_back_insert_out_impl(ContainerType& container):
+            m_container(&container)
+        {
+        }
+
+        shared_base_t create_out_iter_impl()
+        {
+            return std::make_shared<std_back_insert_out_impl<ContainerType>>(*this);
+        }
+
+        void write_block(const value_type* items, size_t count) override
+        {
+            if constexpr (virtual_iter_detail::has_reserve<ContainerType>::value)
+            {
+                size_t required = m_container->size () + count;
+                if (required > m_container->capacity ())
+                    m_container->reserve (std::max (required, 2 * m_container->capacity ()));
+            }
+            m_container->insert (m_container->end (), items, items + count);
+        }
+
+    private:
+        ContainerType* m_container;
+    };
+
+
+    // out_iter impl writing through a raw pointer into preallocated memory such as an mmapped file.
+    // The caller guarantees the destination is large enough.
+    template <typename T>
+    class std_pointer_out_impl: public _out_iter_impl_base<T>
+    {
+    public:
+        typedef _out_iter_impl_base<T> impl_base_t;
+        typedef std::shared_ptr<impl_base_t> shared_base_t;
+
+        std_pointer_out_impl(T* dest):
+            m_dest(dest)
+        {
+        }
+
+        shared_base_t create_out_iter_impl()
+        {
+            return std::make_shared<std_pointer_out_impl<T>>(*this);
+        }
+
+        void write_block(const T* items, size_t count) override
+        {
+            if constexpr (std::is_trivially_copyable<T>::value)
+                std::memcpy (m_dest, items, count * sizeof(T));
+            else
+                std::copy (items, items + count, m_dest);
+
+            m_dest += count;
+        }
+
+    private:
+        T* m_dest;
+    };
+
+
+    // out_iter impl around any standard output iterator, e.g. std::back_insert_iterator or
+    // std::ostream_iterator.  T is explicit because output iterators usually have a void value_type.
+    template <typename T, typename OutputIterType>
+    class std_out_iter_impl: public _out_iter_impl_base<T>
+    {
+    public:
+        typedef _out_iter_impl_base<T> impl_base_t;
+        typedef std::shared_ptr<impl_base_t> shared_base_t;
+
+        std_out_iter_impl(OutputIterType itr):
+            m_itr(itr)
+        {
+        }
+
+        shared_base_t create_out_iter_impl()
+        {
+            return std::make_shared<std_out_iter_impl<T, OutputIterType>>(*this);
+        }
+
+        void write_block(const T* items, size_t count) override
+        {
+            m_itr = std::copy (items, items + count, m_itr);
+        }
+
+    private:
+        OutputIterType m_itr;
     };
 
 
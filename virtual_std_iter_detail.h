@@ -22,7 +22,10 @@
  * THE SOFTWARE.
  */
 #pragma once
+#include <new>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 
 namespace virtual_iter_detail {
@@ -170,4 +173,68 @@ namespace virtual_iter_detail {
             return prototype;
         }
     };
+
+
+    // Identifies iterators whose elements are laid out contiguously in memory so that bulk operations
+    // can drop down to raw pointers. C++17 has no contiguous_iterator_tag so the known std types are listed.
+    template <typename Iter, typename = void>
+    struct is_contiguous_iterator : std::false_type {
+    };
+
+    template <typename T>
+    struct is_contiguous_iterator<T*> : std::true_type {
+    };
+
+    template <typename Iter>
+    struct is_contiguous_iterator<Iter, std::enable_if_t<
+        !std::is_same<typename Iter::value_type, bool>::value &&
+        (std::is_same<Iter, typename std::vector<typename Iter::value_type>::const_iterator>::value ||
+         std::is_same<Iter, typename std::vector<typename Iter::value_type>::iterator>::value)>> : std::true_type {
+    };
+
+    template <>
+    struct is_contiguous_iterator<std::string::const_iterator> : std::true_type {
+    };
+
+    template <>
+    struct is_contiguous_iterator<std::string::iterator> : std::true_type {
+    };
+
+
+    // Detects iterators that can hand out a block of elements in one call, see flat_hash_map::iterator_impl.
+    template <typename Iter, typename = void>
+    struct has_scan_n : std::false_type {
+    };
+
+    template <typename Iter>
+    struct has_scan_n<Iter, std::void_t<decltype(std::declval<Iter&>().scan_n (
+        size_t(), std::declval<const Iter&>(), std::declval<bool(*)(const typename Iter::value_type&)>()))>> : std::true_type {
+    };
+
+
+    template <typename Container, typename = void>
+    struct has_reserve : std::false_type {
+    };
+
+    template <typename Container>
+    struct has_reserve<Container, std::void_t<decltype(std::declval<Container&>().reserve (size_t())),
+                                              decltype(std::declval<const Container&>().capacity ())>> : std::true_type {
+    };
+
+
+    // Bulk copies write into caller supplied buffers of live objects.  Types such as
+    // std::pair<const K, V> cannot be assigned so they are rebuilt in place instead.
+    template <typename T>
+    void assign_element(T& dst, const T& src)
+    {
+        if constexpr (std::is_copy_assignable<T>::value)
+        {
+            dst = src;
+        }
+        else
+        {
+            dst.~T();
+            new (&dst) T (src);
+        }
+    }
 }
\ No newline at end of file